@@ -1,101 +1,308 @@
 #ifndef CHARTDRAWER_H
 #define CHARTDRAWER_H
 
+#include "ChartModel.h"
 #include <QChartView>
 #include <memory>
 #include <string>
+#include <typeinfo>
+#include <vector>
 #include <QPieSeries>
 #include <QPieSlice>
 #include <QBarSeries>
 #include <QBarSet>
 #include <QLineSeries>
 #include <QHorizontalBarSeries>
+#include <QBarCategoryAxis>
+#include <QDateTimeAxis>
+#include <QValueAxis>
+#include <QAbstractAxis>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QPdfWriter>
 
 using namespace QtCharts;
 
+// Палитра черно-белого режима. Он задается цветами серий, а не графическим эффектом,
+// поэтому не требует отрисовки во внеэкранный буфер. Цветной режим берет цвета из темы QChart
+class ChartPalette {
+public:
+    // Самый светлый серый, еще заметный на белом фоне
+    static constexpr int lightestGrey = 180;
+
+    // count различных оттенков серого от черного до lightestGrey, чтобы цвета не повторялись
+    static QList<QColor> greys(int count) {
+        QList<QColor> palette;
+        for (int i = 0; i < count; ++i) {
+            int level = count > 1 ? lightestGrey * i / (count - 1) : 0;
+            palette.append(QColor(level, level, level));
+        }
+        return palette;
+    }
+};
+
+// Рендереры не хранят состояния: построенные серии удерживает RetainedChartModel,
+// поэтому один экземпляр каждого рендерера используется повторно
 class AbstractChartRenderer {
 public:
     virtual ~AbstractChartRenderer() {}
 
-    void renderChart(QList<QPair<QString, QString>> extractedData, std::unique_ptr<QChartView> &chartView) {
-        chartView->chart()->removeAllSeries();
+    void renderChart(RetainedChartModel &model, std::unique_ptr<QChartView> &chartView, bool monochrome) const {
+        QChart *chart = chartView->chart();
+        // Удерживаемые серии отвязываются без удаления, остальное очищается
+        model.detach(chart);
+        chart->removeAllSeries();
+        for (QAbstractAxis *axis: chart->axes()) {
+            chart->removeAxis(axis);
+            delete axis;
+        }
+
         setupChartTitle(chartView);
-        createSeries(extractedData, chartView);
-        setupChartOptions(chartView);
-        chartView->setRenderHint(QPainter::Antialiasing);
+        // Серии строятся только при первом показе набора данных в этом виде
+        QList<QAbstractSeries *> seriesList = model.view(typeid(*this));
+        // Перекрашенные в серый серии получают цвета темы только при создании
+        if (!monochrome && model.isMonochrome(typeid(*this))) {
+            seriesList.clear();
+        }
+        if (seriesList.isEmpty()) {
+            seriesList = model.retain(typeid(*this), viewKind(), createSeries(model, 0));
+        } else if (viewKind() == RetainedChartModel::DatasetView && seriesList.size() < model.datasets().size()) {
+            // К выборке добавились файлы: строятся серии только для них
+            seriesList.append(model.extend(typeid(*this), createSeries(model, seriesList.size())));
+        }
+        for (QAbstractSeries *series: seriesList) {
+            chart->addSeries(series);
+        }
+        if (monochrome) {
+            applyMonochrome(seriesList);
+            model.setMonochrome(typeid(*this), true);
+        }
+        setupAxes(chart, model);
         chartView->update();
     }
 
+    /*
+     * Смена цветового режима без перестроения серий. Серые цвета задаются на месте,
+     * а вернуть цвета темы на месте нельзя: тема не перекрашивает серии с заданными цветами.
+     * Возвращает false, если для цветного режима диаграмму нужно построить заново через renderChart.
+    */
+    bool applyColorMode(RetainedChartModel &model, bool monochrome) const {
+        QList<QAbstractSeries *> seriesList = model.view(typeid(*this));
+        if (seriesList.isEmpty()) {
+            return true;
+        }
+        if (!monochrome) {
+            return !model.isMonochrome(typeid(*this));
+        }
+        applyMonochrome(seriesList);
+        model.setMonochrome(typeid(*this), true);
+        return true;
+    }
+
+    // Число точек, которое реально попадет на диаграмму
+    virtual int renderedPointCount(const RetainedChartModel &model) const {
+        return model.categories().values.size();
+    }
+
+    // Размер диаграммы вдоль оси, по которой раскладываются категории, от него зависит их автоматическое число
+    virtual int categoryExtent(const QSize &size) const {
+        return size.width();
+    }
+
 protected:
-    void setupChartOptions(std::unique_ptr<QChartView> &chartView) {
-        chartView->chart()->setAnimationOptions(QChart::SeriesAnimations);
-    };
+    // Большинство видов строится по сокращенным категориям
+    virtual RetainedChartModel::ViewKind viewKind() const {
+        return RetainedChartModel::CategoryView;
+    }
+
+    virtual void setupAxes(QChart *, const RetainedChartModel &) const {}
+
+    virtual void setupChartTitle(std::unique_ptr<QChartView> &chartView) const = 0;
 
-    virtual void setupChartTitle(std::unique_ptr<QChartView> &chartView) = 0;
+    // Виды по наборам данных строят серии начиная с firstDataset, виды по категориям всегда строятся целиком
+    virtual std::vector<std::unique_ptr<QAbstractSeries>> createSeries(const RetainedChartModel &model,
+                                                                       int firstDataset) const = 0;
 
-    virtual void createSeries(QList<QPair<QString, QString>> extractedData, std::unique_ptr<QChartView> &chartView) = 0;
+    virtual void applyMonochrome(const QList<QAbstractSeries *> &seriesList) const = 0;
 };
 
+// Круговая диаграмма не накладывается, при выборе нескольких файлов она строится по первому из них
 class PieChartRenderer : public AbstractChartRenderer {
 protected:
-    void setupChartTitle(std::unique_ptr<QChartView> &chartView) override {
+    void setupChartTitle(std::unique_ptr<QChartView> &chartView) const override {
         chartView->chart()->setTitle("Круговая диаграмма");
     }
 
-    void createSeries(QList<QPair<QString, QString>> extractedData, std::unique_ptr<QChartView> &chartView) override {
+    std::vector<std::unique_ptr<QAbstractSeries>> createSeries(const RetainedChartModel &model, int) const override {
         std::unique_ptr<QPieSeries> series = std::make_unique<QPieSeries>();
-        for (const QPair<QString, QString> &pair: extractedData) {
-            QString key = pair.first;
-            qreal value = pair.second.toDouble();
-            series->append(key, value);
+        // Число срезов уже ограничено, мелкие категории собраны в "Другое"
+        const CategoryBuckets &categories = model.categories();
+        for (int i = 0; i < categories.keys.size(); ++i) {
+            series->append(categories.keys[i], categories.values[i]);
+        }
+
+        std::vector<std::unique_ptr<QAbstractSeries>> seriesList;
+        seriesList.push_back(std::move(series));
+        return seriesList;
+    }
+
+    void applyMonochrome(const QList<QAbstractSeries *> &seriesList) const override {
+        QList<QPieSlice *> slices = static_cast<QPieSeries *>(seriesList.first())->slices();
+        QList<QColor> palette = ChartPalette::greys(slices.size());
+        for (int i = 0; i < slices.size(); ++i) {
+            slices[i]->setBrush(palette[i]);
         }
-        // Освобождаем указатель
-        chartView->chart()->addSeries(series.release());
     }
 };
 
-class BarChartRenderer : public AbstractChartRenderer {
+/*
+ * Общая часть вертикальной и горизонтальной столбчатых диаграмм.
+ * Один файл показывается набором столбцов по категориям,
+ * несколько файлов - сгруппированными столбцами по выровненным ключам.
+*/
+template<typename TBarSeries, Qt::Orientation categoryOrientation>
+class BasicBarChartRenderer : public AbstractChartRenderer {
+public:
+    int renderedPointCount(const RetainedChartModel &model) const override {
+        if (model.isOverlay()) {
+            return model.overlayCategories().keys.size() * model.overlayCategories().columns.size();
+        }
+        return AbstractChartRenderer::renderedPointCount(model);
+    }
+
+    // Столбцы горизонтальной диаграммы раскладываются по высоте
+    int categoryExtent(const QSize &size) const override {
+        return categoryOrientation == Qt::Horizontal ? size.width() : size.height();
+    }
+
 protected:
-    void setupChartTitle(std::unique_ptr<QChartView> &chartView) override {
-        chartView->chart()->setTitle("Столбчатая диаграмма");
+    std::vector<std::unique_ptr<QAbstractSeries>> createSeries(const RetainedChartModel &model, int) const override {
+        std::unique_ptr<TBarSeries> series(new TBarSeries());
+        if (model.isOverlay()) {
+            // Число ключей уже ограничено так же, как число категорий одного файла
+            const OverlayBuckets &categories = model.overlayCategories();
+            for (int column = 0; column < categories.columns.size(); ++column) {
+                std::unique_ptr<QBarSet> barSet(new QBarSet(model.aligned()->names[column]));
+                for (qreal value: categories.columns[column]) {
+                    *barSet << value;
+                }
+                series->append(barSet.release());
+            }
+        } else {
+            const CategoryBuckets &categories = model.categories();
+            for (int i = 0; i < categories.keys.size(); ++i) {
+                std::unique_ptr<QBarSet> barSet(new QBarSet(categories.keys[i]));
+                *barSet << categories.values[i];
+                series->append(barSet.release());
+            }
+        }
+
+        std::vector<std::unique_ptr<QAbstractSeries>> seriesList;
+        seriesList.push_back(std::move(series));
+        return seriesList;
     }
 
-    void createSeries(QList<QPair<QString, QString>> extractedData, std::unique_ptr<QChartView> &chartView) override {
-        std::unique_ptr<QBarSeries> series(new QBarSeries());
-        for (const QPair<QString, QString> &pair: extractedData) {
-            QString key = pair.first;
-            qreal value = pair.second.toDouble();
+    void applyMonochrome(const QList<QAbstractSeries *> &seriesList) const override {
+        QList<QBarSet *> barSets = static_cast<TBarSeries *>(seriesList.first())->barSets();
+        QList<QColor> palette = ChartPalette::greys(barSets.size());
+        for (int i = 0; i < barSets.size(); ++i) {
+            barSets[i]->setColor(palette[i]);
+        }
+    }
 
-            std::unique_ptr<QBarSet> barSet(new QBarSet(key));
-            *barSet << value;
-            series->append(barSet.release());
+    // Общая ось категорий для наложенных файлов
+    void setupAxes(QChart *chart, const RetainedChartModel &model) const override {
+        if (!model.isOverlay()) {
+            return;
+        }
+        chart->createDefaultAxes();
+        for (QAbstractAxis *axis: chart->axes(categoryOrientation)) {
+            QBarCategoryAxis *categoryAxis = qobject_cast<QBarCategoryAxis *>(axis);
+            if (categoryAxis) {
+                categoryAxis->setCategories(model.overlayCategories().keys);
+            }
         }
-        // Освобождаем указатель
-        chartView->chart()->addSeries(series.release());
     }
 };
 
-class HorizontalBarChartRenderer : public AbstractChartRenderer {
+class BarChartRenderer : public BasicBarChartRenderer<QBarSeries, Qt::Horizontal> {
 protected:
-    void setupChartTitle(std::unique_ptr<QChartView> &chartView) override {
+    void setupChartTitle(std::unique_ptr<QChartView> &chartView) const override {
+        chartView->chart()->setTitle("Столбчатая диаграмма");
+    }
+};
+
+class HorizontalBarChartRenderer : public BasicBarChartRenderer<QHorizontalBarSeries, Qt::Vertical> {
+protected:
+    void setupChartTitle(std::unique_ptr<QChartView> &chartView) const override {
         chartView->chart()->setTitle("Столбчатая горизонтальная диаграмма");
     }
+};
+
+// Наложенные файлы рисуются отдельными линиями на общих осях
+class LineChartRenderer : public AbstractChartRenderer {
+public:
+    int renderedPointCount(const RetainedChartModel &model) const override {
+        int pointCount = 0;
+        for (const std::shared_ptr<const PreparedChartData> &dataset: model.datasets()) {
+            pointCount += dataset->linePoints.size();
+        }
+        return pointCount;
+    }
 
-    void createSeries(QList<QPair<QString, QString>> extractedData, std::unique_ptr<QChartView> &chartView) override {
-        std::unique_ptr<QHorizontalBarSeries> series(new QHorizontalBarSeries());
-        for (const QPair<QString, QString> &pair: extractedData) {
-            QString key = pair.first;
-            qreal value = pair.second.toDouble();
+protected:
+    void setupChartTitle(std::unique_ptr<QChartView> &chartView) const override {
+        chartView->chart()->setTitle("Линейная диаграмма");
+    }
+
+    // Линии строятся по прореженным точкам и не зависят от числа категорий
+    RetainedChartModel::ViewKind viewKind() const override {
+        return RetainedChartModel::DatasetView;
+    }
 
-            std::unique_ptr<QBarSet> barSet(new QBarSet(key));
-            *barSet << value;
-            series->append(barSet.release());
+    // Точки стоят на позициях ключей, поэтому линии уже построенных наборов не зависят от добавленных
+    std::vector<std::unique_ptr<QAbstractSeries>> createSeries(const RetainedChartModel &model,
+                                                               int firstDataset) const override {
+        std::vector<std::unique_ptr<QAbstractSeries>> seriesList;
+        const QVector<std::shared_ptr<const PreparedChartData>> &datasets = model.datasets();
+        for (int dataset = firstDataset; dataset < datasets.size(); ++dataset) {
+            std::unique_ptr<QLineSeries> series = std::make_unique<QLineSeries>();
+            series->setName(datasets[dataset]->name);
+            // Берем уже прореженный буфер, а не все исходные точки
+            series->replace(datasets[dataset]->linePoints);
+            seriesList.push_back(std::move(series));
+        }
+        return seriesList;
+    }
+
+    void applyMonochrome(const QList<QAbstractSeries *> &seriesList) const override {
+        QList<QColor> palette = ChartPalette::greys(seriesList.size());
+        for (int i = 0; i < seriesList.size(); ++i) {
+            QLineSeries *lineSeries = static_cast<QLineSeries *>(seriesList[i]);
+            QPen pen = lineSeries->pen();
+            pen.setColor(palette[i]);
+            lineSeries->setPen(pen);
+        }
+    }
+
+    // Одна пара осей, общая для всех линий. Даты подписываются датами, а не миллисекундами
+    void setupAxes(QChart *chart, const RetainedChartModel &model) const override {
+        if (model.data()->keyKind != PreparedChartData::DateKey) {
+            chart->createDefaultAxes();
+            return;
+        }
+        std::unique_ptr<QDateTimeAxis> axisX = std::make_unique<QDateTimeAxis>();
+        axisX->setFormat("dd.MM.yyyy");
+        std::unique_ptr<QValueAxis> axisY = std::make_unique<QValueAxis>();
+        // Владельцем осей становится QChart
+        chart->addAxis(axisX.get(), Qt::AlignBottom);
+        chart->addAxis(axisY.get(), Qt::AlignLeft);
+        for (QAbstractSeries *series: chart->series()) {
+            series->attachAxis(axisX.get());
+            series->attachAxis(axisY.get());
         }
-        // Освобождаем указатель
-        chartView->chart()->addSeries(series.release());
+        axisX.release();
+        axisY.release();
     }
 };
 
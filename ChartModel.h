@@ -0,0 +1,760 @@
+#ifndef CHARTMODEL_H
+#define CHARTMODEL_H
+
+#include <QAbstractSeries>
+#include <QChart>
+#include <QDate>
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QPointF>
+#include <QStringList>
+#include <QTime>
+#include <QVector>
+#include <QtNumeric>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <vector>
+
+using namespace QtCharts;
+
+// Подготовленные данные файла. Строятся один раз на набор данных и используются всеми видами диаграмм
+class PreparedChartData
+{
+public:
+    // Максимальное число точек, которое получает линейная диаграмма
+    static constexpr int maxLinePoints = 2000;
+
+    // Вид ключей определяется по всему файлу: ключи одного файла либо все даты, либо все числа
+    enum KeyKind {
+        DateKey,    // Позиция ключа - миллисекунды от начала эпохи
+        NumberKey,  // Позиция ключа - само число
+        TextKey     // Позиция ключа - номер строки, с другими файлами такие ключи не выравниваются
+    };
+
+    // Название набора данных для легенды, обычно имя файла
+    QString name;
+    KeyKind keyKind = TextKey;
+    QStringList keys;
+    QVector<qreal> values;
+    // Позиция ключа на оси, по ней наборы данных выравниваются друг с другом
+    QVector<qreal> keyOrder;
+    // Прореженный буфер точек для линейной диаграммы, X - позиция ключа на оси
+    QVector<QPointF> linePoints;
+    // Значения, просуммированные по уникальным ключам, в порядке первого появления ключа
+    QStringList categoryKeys;
+    QVector<qreal> categoryValues;
+
+    static std::shared_ptr<const PreparedChartData> prepare(const QList<QPair<QString, QString>> &extractedData,
+                                                            const QString &name = QString())
+    {
+        std::shared_ptr<PreparedChartData> prepared = std::make_shared<PreparedChartData>();
+        prepared->name = name;
+        prepared->keys.reserve(extractedData.size());
+        prepared->values.reserve(extractedData.size());
+        prepared->keyOrder.reserve(extractedData.size());
+
+        // Строки переводим в числа один раз, а не при каждой отрисовке
+        for (const QPair<QString, QString> &pair: extractedData) {
+            prepared->keys.append(pair.first);
+            prepared->values.append(pair.second.toDouble());
+        }
+        prepared->keyKind = keyKindOf(prepared->keys);
+        for (int i = 0; i < prepared->keys.size(); ++i) {
+            prepared->keyOrder.append(orderOf(prepared->keys[i], i, prepared->keyKind));
+        }
+        prepared->sortByKey();
+
+        // Точки стоят на позициях ключей, поэтому линия не зависит от того, с какими файлами она наложена
+        QVector<QPointF> points;
+        points.reserve(prepared->values.size());
+        for (int i = 0; i < prepared->values.size(); ++i) {
+            points.append(QPointF(prepared->keyOrder[i], prepared->values[i]));
+        }
+        prepared->linePoints = decimate(points, maxLinePoints);
+        prepared->aggregateCategories();
+
+        return prepared;
+    }
+
+    // Ключи сравниваются по позиции на оси, а при равных позициях - как строки
+    static bool keyLess(qreal leftOrder, const QString &leftKey, qreal rightOrder, const QString &rightKey)
+    {
+        if (leftOrder != rightOrder) {
+            return leftOrder < rightOrder;
+        }
+        return leftKey < rightKey;
+    }
+
+    bool keyLess(int left, const PreparedChartData &other, int right) const
+    {
+        return keyLess(keyOrder[left], keys[left], other.keyOrder[right], other.keys[right]);
+    }
+
+    // Прореживание по корзинам: из каждой корзины сохраняются минимум и максимум, поэтому пики не теряются
+    static QVector<QPointF> decimate(const QVector<QPointF> &points, int maxPoints)
+    {
+        int count = points.size();
+        if (count <= maxPoints) {
+            return points;
+        }
+
+        QVector<QPointF> decimated;
+        int bucketCount = maxPoints / 2;
+        decimated.reserve(bucketCount * 2);
+        for (int bucket = 0; bucket < bucketCount; ++bucket) {
+            int begin = static_cast<int>(static_cast<qint64>(bucket) * count / bucketCount);
+            int end = static_cast<int>(static_cast<qint64>(bucket + 1) * count / bucketCount);
+
+            int minIndex = begin;
+            int maxIndex = begin;
+            for (int i = begin + 1; i < end; ++i) {
+                if (points[i].y() < points[minIndex].y()) {
+                    minIndex = i;
+                }
+                if (points[i].y() > points[maxIndex].y()) {
+                    maxIndex = i;
+                }
+            }
+
+            // Точки добавляем в порядке следования по оси X
+            decimated.append(points[qMin(minIndex, maxIndex)]);
+            if (minIndex != maxIndex) {
+                decimated.append(points[qMax(minIndex, maxIndex)]);
+            }
+        }
+
+        return decimated;
+    }
+
+private:
+    static KeyKind keyKindOf(const QStringList &keys)
+    {
+        bool isDate = true;
+        bool isNumber = true;
+        for (const QString &key: keys) {
+            if (isDate && !QDate::fromString(key, "dd.MM.yyyy").isValid()) {
+                isDate = false;
+            }
+            if (isNumber) {
+                key.toDouble(&isNumber);
+            }
+            if (!isDate && !isNumber) {
+                return TextKey;
+            }
+        }
+        return isDate ? DateKey : NumberKey;
+    }
+
+    // Даты и числа занимают на оси свое место, остальные ключи идут в порядке следования
+    static qreal orderOf(const QString &key, int index, KeyKind kind)
+    {
+        switch (kind) {
+        case DateKey:
+            return QDateTime(QDate::fromString(key, "dd.MM.yyyy"), QTime(0, 0)).toMSecsSinceEpoch();
+        case NumberKey:
+            return key.toDouble();
+        default:
+            return index;
+        }
+    }
+
+    // Обычно ключи уже упорядочены, и сортировка не выполняется. Иначе она делается один раз при подготовке,
+    // чтобы при выравнивании наборов данных ничего не пересортировывать
+    void sortByKey()
+    {
+        std::vector<int> permutation(keys.size());
+        for (int i = 0; i < keys.size(); ++i) {
+            permutation[i] = i;
+        }
+        auto less = [this](int left, int right) {
+            return keyLess(left, *this, right);
+        };
+        if (std::is_sorted(permutation.begin(), permutation.end(), less)) {
+            return;
+        }
+        std::stable_sort(permutation.begin(), permutation.end(), less);
+
+        QStringList sortedKeys;
+        QVector<qreal> sortedValues;
+        QVector<qreal> sortedOrder;
+        sortedKeys.reserve(keys.size());
+        sortedValues.reserve(keys.size());
+        sortedOrder.reserve(keys.size());
+        for (int index: permutation) {
+            sortedKeys.append(keys[index]);
+            sortedValues.append(values[index]);
+            sortedOrder.append(keyOrder[index]);
+        }
+        keys = std::move(sortedKeys);
+        values = std::move(sortedValues);
+        keyOrder = std::move(sortedOrder);
+    }
+
+    void aggregateCategories()
+    {
+        QHash<QString, int> categoryIndex;
+        categoryIndex.reserve(keys.size());
+        for (int i = 0; i < keys.size(); ++i) {
+            auto it = categoryIndex.constFind(keys[i]);
+            if (it != categoryIndex.constEnd()) {
+                categoryValues[it.value()] += values[i];
+            } else {
+                categoryIndex.insert(keys[i], categoryKeys.size());
+                categoryKeys.append(keys[i]);
+                categoryValues.append(values[i]);
+            }
+        }
+    }
+};
+
+// Категории для круговой и столбчатых диаграмм после сокращения числа ключей
+class CategoryBuckets
+{
+public:
+    // Место вдоль оси категорий, которое должна занимать одна категория при автоматическом выборе их числа
+    static constexpr int autoCategoryExtent = 40;
+    static constexpr int minAutoCategories = 3;
+    static constexpr int maxAutoCategories = 50;
+
+    QStringList keys;
+    QVector<qreal> values;
+
+    static int limitForExtent(int extent)
+    {
+        return qBound(minAutoCategories, extent / autoCategoryExtent, maxAutoCategories);
+    }
+
+    /*
+     * Оставляет limit категорий с наибольшими значениями, остальные собираются в "Другое".
+     * Лучшие категории отбираются ограниченной кучей: O(n log K) времени и O(K) дополнительной памяти.
+     * Выбранные категории сохраняют исходный порядок ключей.
+    */
+    static CategoryBuckets reduce(const PreparedChartData &data, int limit)
+    {
+        CategoryBuckets buckets;
+        const QVector<qreal> &values = data.categoryValues;
+
+        // Одна категория в "Другое" ничего не сокращает, а только прячет свою подпись
+        if (limit <= 0 || values.size() <= limit + 1) {
+            buckets.keys = data.categoryKeys;
+            buckets.values = values;
+            return buckets;
+        }
+
+        // На вершине кучи находится наименьшая из отобранных категорий
+        auto greater = [&values](int left, int right) {
+            return values[left] > values[right];
+        };
+        std::vector<int> top;
+        top.reserve(limit);
+        qreal total = 0;
+        for (int i = 0; i < values.size(); ++i) {
+            total += values[i];
+            if (static_cast<int>(top.size()) < limit) {
+                top.push_back(i);
+                std::push_heap(top.begin(), top.end(), greater);
+            } else if (values[i] > values[top.front()]) {
+                std::pop_heap(top.begin(), top.end(), greater);
+                top.back() = i;
+                std::push_heap(top.begin(), top.end(), greater);
+            }
+        }
+        std::sort(top.begin(), top.end());
+
+        buckets.keys.reserve(limit + 1);
+        buckets.values.reserve(limit + 1);
+        qreal other = total;
+        for (int index: top) {
+            buckets.keys.append(data.categoryKeys[index]);
+            buckets.values.append(values[index]);
+            other -= values[index];
+        }
+        buckets.keys.append("Другое");
+        buckets.values.append(other);
+
+        return buckets;
+    }
+};
+
+/*
+ * Несколько наборов данных, выровненных по общему ключу для наложения на одну диаграмму.
+ * Выравнивать можно только наборы с ключами одного вида - датами или числами (см. canAlign):
+ * у текстовых ключей позиция на оси - номер строки, и один и тот же ключ попал бы в разные строки.
+*/
+class AlignedChartData
+{
+public:
+    // Объединение ключей всех наборов в порядке оси
+    QStringList keys;
+    QVector<qreal> keyOrder;
+    QStringList names;
+    // По столбцу на набор данных, отсутствующие значения равны NaN
+    QVector<QVector<qreal>> columns;
+
+    static bool canAlign(const QVector<std::shared_ptr<const PreparedChartData>> &datasets)
+    {
+        if (datasets.size() < 2) {
+            return true;
+        }
+        PreparedChartData::KeyKind kind = datasets.first()->keyKind;
+        if (kind == PreparedChartData::TextKey) {
+            return false;
+        }
+        for (const std::shared_ptr<const PreparedChartData> &dataset: datasets) {
+            if (dataset->keyKind != kind) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * Потоковое k-путевое слияние уже упорядоченных ключей.
+     * Курсоры наборов хранятся в куче размера k, поэтому слияние занимает O(N log k)
+     * без хеш-таблиц и без повторной сортировки. Используется, когда выборка построена заново.
+    */
+    static std::shared_ptr<const AlignedChartData> merge(const QVector<std::shared_ptr<const PreparedChartData>> &datasets)
+    {
+        std::shared_ptr<AlignedChartData> aligned = std::make_shared<AlignedChartData>();
+        int datasetCount = datasets.size();
+        aligned->columns.resize(datasetCount);
+
+        struct Cursor {
+            int dataset;
+            int position;
+        };
+        // На вершине кучи находится курсор с наименьшим ключом
+        auto later = [&datasets](const Cursor &left, const Cursor &right) {
+            return datasets[right.dataset]->keyLess(right.position, *datasets[left.dataset], left.position);
+        };
+
+        std::vector<Cursor> heap;
+        heap.reserve(datasetCount);
+        for (int dataset = 0; dataset < datasetCount; ++dataset) {
+            aligned->names.append(datasets[dataset]->name);
+            if (!datasets[dataset]->keys.isEmpty()) {
+                heap.push_back({dataset, 0});
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), later);
+
+        std::vector<Cursor> advanced;
+        advanced.reserve(datasetCount);
+        while (!heap.empty()) {
+            Cursor current = heap.front();
+            const PreparedChartData &currentData = *datasets[current.dataset];
+            aligned->keys.append(currentData.keys[current.position]);
+            aligned->keyOrder.append(currentData.keyOrder[current.position]);
+            for (QVector<qreal> &column: aligned->columns) {
+                column.append(qQNaN());
+            }
+
+            // Забираем из кучи все курсоры с тем же ключом, это одна строка выровненных данных
+            while (!heap.empty()) {
+                Cursor top = heap.front();
+                const PreparedChartData &topData = *datasets[top.dataset];
+                if (currentData.keyLess(current.position, topData, top.position)) {
+                    break;
+                }
+                std::pop_heap(heap.begin(), heap.end(), later);
+                heap.pop_back();
+                aligned->columns[top.dataset].last() = topData.values[top.position];
+                if (++top.position < topData.keys.size()) {
+                    advanced.push_back(top);
+                }
+            }
+            // Сдвинутые курсоры возвращаются после строки, чтобы повтор ключа в одном наборе дал новую строку
+            for (const Cursor &cursor: advanced) {
+                heap.push_back(cursor);
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+            advanced.clear();
+        }
+
+        return aligned;
+    }
+
+    /*
+     * Добавление одного набора к уже выровненным данным двухпутевым слиянием за O(строк + ключей набора).
+     * Повторяющиеся ключи сопоставляются по порядку, как и при k-путевом слиянии,
+     * поэтому результат совпадает с merge() по всей выборке.
+    */
+    static std::shared_ptr<const AlignedChartData> append(const AlignedChartData &aligned,
+                                                          const PreparedChartData &dataset)
+    {
+        std::shared_ptr<AlignedChartData> merged = std::make_shared<AlignedChartData>();
+        int rowCount = aligned.keys.size();
+        int columnCount = aligned.columns.size();
+        int capacity = rowCount + dataset.keys.size();
+        merged->names = aligned.names;
+        merged->names.append(dataset.name);
+        merged->keys.reserve(capacity);
+        merged->keyOrder.reserve(capacity);
+        merged->columns.resize(columnCount + 1);
+        for (QVector<qreal> &column: merged->columns) {
+            column.reserve(capacity);
+        }
+
+        int row = 0;
+        int position = 0;
+        while (row < rowCount || position < dataset.keys.size()) {
+            bool takeRow = position == dataset.keys.size()
+                    || (row < rowCount && PreparedChartData::keyLess(aligned.keyOrder[row], aligned.keys[row],
+                                                                     dataset.keyOrder[position],
+                                                                     dataset.keys[position]));
+            bool takeKey = row == rowCount
+                    || (!takeRow && PreparedChartData::keyLess(dataset.keyOrder[position], dataset.keys[position],
+                                                               aligned.keyOrder[row], aligned.keys[row]));
+
+            if (takeKey) {
+                merged->keys.append(dataset.keys[position]);
+                merged->keyOrder.append(dataset.keyOrder[position]);
+            } else {
+                merged->keys.append(aligned.keys[row]);
+                merged->keyOrder.append(aligned.keyOrder[row]);
+            }
+            for (int column = 0; column < columnCount; ++column) {
+                merged->columns[column].append(takeKey ? qQNaN() : aligned.columns[column][row]);
+            }
+            merged->columns[columnCount].append(takeRow ? qQNaN() : dataset.values[position]);
+
+            // Равные ключи образуют одну строку
+            if (!takeKey) {
+                ++row;
+            }
+            if (!takeRow) {
+                ++position;
+            }
+        }
+
+        return merged;
+    }
+};
+
+/*
+ * Строки наложенных столбчатых диаграмм после сокращения числа ключей.
+ * Строки с одинаковым ключом объединяются, поэтому подписи оси категорий уникальны
+ * и не сдвигаются относительно столбцов.
+*/
+class OverlayBuckets
+{
+public:
+    QStringList keys;
+    // По столбцу на набор данных, отсутствующие значения считаются нулем
+    QVector<QVector<qreal>> columns;
+
+    /*
+     * Оставляет limit ключей с наибольшей суммой по всем наборам, остальные собираются в "Другое".
+     * Как и в CategoryBuckets, лучшие ключи отбираются ограниченной кучей за O(n log K),
+     * а выбранные ключи сохраняют порядок оси.
+    */
+    static OverlayBuckets reduce(const AlignedChartData &aligned, int limit)
+    {
+        OverlayBuckets buckets;
+        int rowCount = aligned.keys.size();
+        int columnCount = aligned.columns.size();
+        buckets.columns.resize(columnCount);
+
+        // Выровненные строки упорядочены, поэтому одинаковые ключи стоят подряд
+        std::vector<int> groupStarts;
+        QVector<qreal> totals;
+        for (int row = 0; row < rowCount; ++row) {
+            if (row == 0 || aligned.keys[row] != aligned.keys[row - 1]) {
+                groupStarts.push_back(row);
+                totals.append(0);
+            }
+            for (const QVector<qreal> &column: aligned.columns) {
+                if (!qIsNaN(column[row])) {
+                    totals.last() += column[row];
+                }
+            }
+        }
+        int groupCount = static_cast<int>(groupStarts.size());
+        groupStarts.push_back(rowCount);
+
+        std::vector<int> top;
+        // Как и в CategoryBuckets, "Другое" появляется, только если в него попадают хотя бы два ключа
+        if (limit <= 0 || groupCount <= limit + 1) {
+            top.resize(groupCount);
+            for (int group = 0; group < groupCount; ++group) {
+                top[group] = group;
+            }
+        } else {
+            // На вершине кучи находится наименьший из отобранных ключей
+            auto greater = [&totals](int left, int right) {
+                return totals[left] > totals[right];
+            };
+            top.reserve(limit);
+            for (int group = 0; group < groupCount; ++group) {
+                if (static_cast<int>(top.size()) < limit) {
+                    top.push_back(group);
+                    std::push_heap(top.begin(), top.end(), greater);
+                } else if (totals[group] > totals[top.front()]) {
+                    std::pop_heap(top.begin(), top.end(), greater);
+                    top.back() = group;
+                    std::push_heap(top.begin(), top.end(), greater);
+                }
+            }
+            std::sort(top.begin(), top.end());
+        }
+
+        int keptCount = static_cast<int>(top.size());
+        bool hasOther = keptCount < groupCount;
+        buckets.keys.reserve(keptCount + 1);
+        for (QVector<qreal> &column: buckets.columns) {
+            column.reserve(keptCount + 1);
+        }
+        QVector<qreal> other(columnCount, 0);
+        std::size_t next = 0;
+        for (int group = 0; group < groupCount; ++group) {
+            bool isKept = next < top.size() && top[next] == group;
+            if (isKept) {
+                ++next;
+                buckets.keys.append(aligned.keys[groupStarts[group]]);
+            }
+            for (int column = 0; column < columnCount; ++column) {
+                qreal sum = 0;
+                for (int row = groupStarts[group]; row < groupStarts[group + 1]; ++row) {
+                    qreal value = aligned.columns[column][row];
+                    if (!qIsNaN(value)) {
+                        sum += value;
+                    }
+                }
+                if (isKept) {
+                    buckets.columns[column].append(sum);
+                } else {
+                    other[column] += sum;
+                }
+            }
+        }
+        if (hasOther) {
+            buckets.keys.append("Другое");
+            for (int column = 0; column < columnCount; ++column) {
+                buckets.columns[column].append(other[column]);
+            }
+        }
+
+        return buckets;
+    }
+};
+
+// Удерживаемая модель диаграммы: подготовленные данные выбранных файлов и уже построенные по ним серии.
+// При смене типа диаграммы серии не пересоздаются, а только заново привязываются к QChart
+class RetainedChartModel
+{
+public:
+    // От чего зависят серии вида, по этому решается, какие виды перестраивать
+    enum ViewKind {
+        CategoryView,   // Строится по сокращенным категориям и зависит от их числа
+        DatasetView     // Строится по точкам наборов данных, от числа категорий не зависит
+    };
+
+    // Основной набор данных, по нему строятся диаграммы, которые нельзя наложить друг на друга
+    std::shared_ptr<const PreparedChartData> data() const
+    {
+        return preparedDatasets.isEmpty() ? nullptr : preparedDatasets.first();
+    }
+
+    const QVector<std::shared_ptr<const PreparedChartData>> &datasets() const
+    {
+        return preparedDatasets;
+    }
+
+    bool isOverlay() const
+    {
+        return preparedDatasets.size() > 1;
+    }
+
+    const std::shared_ptr<const AlignedChartData> &aligned() const
+    {
+        return alignedData;
+    }
+
+    const CategoryBuckets &categories() const
+    {
+        return categoryBuckets;
+    }
+
+    // Сокращенные строки наложенных наборов, пусты при одном наборе
+    const OverlayBuckets &overlayCategories() const
+    {
+        return overlayBuckets;
+    }
+
+    /*
+     * Привязка наборов данных. Если к выборке только добавились файлы, они вливаются в уже выровненные данные,
+     * а серии, построенные по отдельным наборам, сохраняются и потом лишь дополняются.
+     * Иначе все серии удаляются и данные выравниваются заново.
+    */
+    void setData(QVector<std::shared_ptr<const PreparedChartData>> newDatasets, QChart *chart)
+    {
+        int keptCount = preparedDatasets.size();
+        bool isExtended = keptCount > 0 && newDatasets.size() >= keptCount
+                && std::equal(preparedDatasets.begin(), preparedDatasets.end(), newDatasets.begin());
+        if (isExtended) {
+            if (newDatasets.size() == keptCount) {
+                return;
+            }
+            clearViews(chart, CategoryView);
+            for (int i = keptCount; i < newDatasets.size(); ++i) {
+                alignedData = AlignedChartData::append(*alignedData, *newDatasets[i]);
+            }
+        } else {
+            clearViews(chart);
+            alignedData = AlignedChartData::merge(newDatasets);
+        }
+        preparedDatasets = std::move(newDatasets);
+        reduceCategories();
+    }
+
+    int currentCategoryLimit() const
+    {
+        return categoryLimit;
+    }
+
+    // Смена числа категорий перестраивает серии только если число действительно изменилось
+    void setCategoryLimit(int limit, QChart *chart)
+    {
+        if (limit == categoryLimit) {
+            return;
+        }
+        categoryLimit = limit;
+        if (data()) {
+            clearViews(chart, CategoryView);
+            reduceCategories();
+        }
+    }
+
+    // Отвязывает удерживаемые серии от диаграммы без их удаления
+    void detach(QChart *chart)
+    {
+        for (auto &view: views) {
+            for (QAbstractSeries *series: view.second.series) {
+                if (series && series->chart() == chart) {
+                    // QChart возвращает владение серией, поэтому сразу забираем его себе
+                    chart->removeSeries(series);
+                    series->setParent(&seriesOwner);
+                }
+            }
+        }
+    }
+
+    QList<QAbstractSeries *> view(const std::type_index &viewType) const
+    {
+        QList<QAbstractSeries *> seriesList;
+        auto it = views.find(viewType);
+        if (it != views.end()) {
+            for (QAbstractSeries *series: it->second.series) {
+                // Если часть серий удалил сам QChart, вид строится заново
+                if (!series) {
+                    return QList<QAbstractSeries *>();
+                }
+                seriesList.append(series);
+            }
+        }
+        return seriesList;
+    }
+
+    QList<QAbstractSeries *> retain(const std::type_index &viewType, ViewKind kind,
+                                    std::vector<std::unique_ptr<QAbstractSeries>> seriesList)
+    {
+        RetainedView &view = views[viewType];
+        for (QAbstractSeries *series: view.series) {
+            delete series;
+        }
+        view.series.clear();
+        view.kind = kind;
+        view.isMonochrome = false;
+        return adopt(view, std::move(seriesList));
+    }
+
+    // Серии вида перекрашены в серый, и цвета темы им уже не вернуть
+    bool isMonochrome(const std::type_index &viewType) const
+    {
+        auto it = views.find(viewType);
+        return it != views.end() && it->second.isMonochrome;
+    }
+
+    void setMonochrome(const std::type_index &viewType, bool monochrome)
+    {
+        auto it = views.find(viewType);
+        if (it != views.end()) {
+            it->second.isMonochrome = monochrome;
+        }
+    }
+
+    // Дополняет вид сериями добавленных наборов данных, уже удерживаемые серии остаются как есть
+    QList<QAbstractSeries *> extend(const std::type_index &viewType,
+                                    std::vector<std::unique_ptr<QAbstractSeries>> seriesList)
+    {
+        return adopt(views[viewType], std::move(seriesList));
+    }
+
+private:
+    struct RetainedView {
+        ViewKind kind = CategoryView;
+        bool isMonochrome = false;
+        // QPointer обнуляется, если серию удалил сам QChart
+        QList<QPointer<QAbstractSeries>> series;
+    };
+
+    void reduceCategories()
+    {
+        categoryBuckets = data() ? CategoryBuckets::reduce(*data(), categoryLimit) : CategoryBuckets();
+        overlayBuckets = isOverlay() ? OverlayBuckets::reduce(*alignedData, categoryLimit) : OverlayBuckets();
+    }
+
+    QList<QAbstractSeries *> adopt(RetainedView &view, std::vector<std::unique_ptr<QAbstractSeries>> seriesList)
+    {
+        QList<QAbstractSeries *> retained;
+        for (std::unique_ptr<QAbstractSeries> &series: seriesList) {
+            series->setParent(&seriesOwner);
+            // Освобождаем указатель, владельцем становится seriesOwner
+            retained.append(series.release());
+            view.series.append(retained.last());
+        }
+        return retained;
+    }
+
+    void clearViews(QChart *chart)
+    {
+        detach(chart);
+        for (auto &view: views) {
+            for (QAbstractSeries *series: view.second.series) {
+                delete series;
+            }
+        }
+        views.clear();
+    }
+
+    // Удаляет только виды указанного типа, остальные серии остаются удерживаемыми
+    void clearViews(QChart *chart, ViewKind kind)
+    {
+        detach(chart);
+        for (auto it = views.begin(); it != views.end();) {
+            if (it->second.kind != kind) {
+                ++it;
+                continue;
+            }
+            for (QAbstractSeries *series: it->second.series) {
+                delete series;
+            }
+            it = views.erase(it);
+        }
+    }
+
+    QVector<std::shared_ptr<const PreparedChartData>> preparedDatasets;
+    std::shared_ptr<const AlignedChartData> alignedData;
+    CategoryBuckets categoryBuckets;
+    OverlayBuckets overlayBuckets;
+    // Ноль означает, что категории не сокращаются
+    int categoryLimit = 0;
+    std::map<std::type_index, RetainedView> views;
+    QObject seriesOwner;
+};
+
+#endif // CHARTMODEL_H
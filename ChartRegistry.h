@@ -0,0 +1,167 @@
+#ifndef CHARTREGISTRY_H
+#define CHARTREGISTRY_H
+
+#include "ChartDrawer.h"
+#include "DataExtractor.h"
+#include <QFileInfo>
+#include <QLatin1String>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+/*
+ * Реестр рендереров и извлекателей данных, собираемый на этапе компиляции.
+ * Чтобы добавить диаграмму или формат, нужно добавить значение в перечисление перед Count,
+ * строку в таблицу описаний и специализацию ChartRendererType или DataExtractorType.
+ * Экземпляры создаются один раз и не имеют состояния, поэтому их можно использовать из любого потока,
+ * а поиск сводится к обращению к массиву по индексу без выделения памяти.
+*/
+
+enum class ChartType {
+    Bar,
+    Pie,
+    HorizontalBar,
+    Line,
+    Count
+};
+
+enum class DataFormat {
+    Sqlite,
+    Json,
+    Csv,
+    Count
+};
+
+struct ChartTypeInfo {
+    ChartType id;
+    const char *title;
+};
+
+struct DataFormatInfo {
+    DataFormat id;
+    const char *extension;
+    // Формат можно читать потоково, в том числе из сжатого файла
+    bool isStreamable;
+};
+
+// Порядок строк совпадает с порядком значений перечисления, в нем же диаграммы показываются в списке
+constexpr ChartTypeInfo chartTypes[] = {
+    {ChartType::Bar, "Столбчатая диаграмма"},
+    {ChartType::Pie, "Круговая диаграмма"},
+    {ChartType::HorizontalBar, "Горизонтальная столбчатая диаграмма"},
+    {ChartType::Line, "Линейная диаграмма"},
+};
+
+constexpr DataFormatInfo dataFormats[] = {
+    // SQLite читает базу с произвольным доступом, потоково ее не распаковать
+    {DataFormat::Sqlite, "sqlite", false},
+    {DataFormat::Json, "json", true},
+    {DataFormat::Csv, "csv", true},
+};
+
+template<typename TInfo, std::size_t size>
+constexpr bool isOrderedById(const TInfo (&infos)[size]) {
+    for (std::size_t i = 0; i < size; ++i) {
+        if (static_cast<std::size_t>(infos[i].id) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(std::size(chartTypes) == static_cast<std::size_t>(ChartType::Count) && isOrderedById(chartTypes),
+              "chartTypes must describe every ChartType in declaration order");
+static_assert(std::size(dataFormats) == static_cast<std::size_t>(DataFormat::Count) && isOrderedById(dataFormats),
+              "dataFormats must describe every DataFormat in declaration order");
+
+template<ChartType type>
+struct ChartRendererType;
+
+template<>
+struct ChartRendererType<ChartType::Bar> {
+    using Type = BarChartRenderer;
+};
+
+template<>
+struct ChartRendererType<ChartType::Pie> {
+    using Type = PieChartRenderer;
+};
+
+template<>
+struct ChartRendererType<ChartType::HorizontalBar> {
+    using Type = HorizontalBarChartRenderer;
+};
+
+template<>
+struct ChartRendererType<ChartType::Line> {
+    using Type = LineChartRenderer;
+};
+
+template<DataFormat format>
+struct DataExtractorType;
+
+template<>
+struct DataExtractorType<DataFormat::Sqlite> {
+    using Type = SqlDataExtractor;
+};
+
+template<>
+struct DataExtractorType<DataFormat::Json> {
+    using Type = JsonDataExtractor;
+};
+
+template<>
+struct DataExtractorType<DataFormat::Csv> {
+    using Type = CsvDataExtractor;
+};
+
+// Единственный экземпляр каждого рендерера и извлекателя
+template<ChartType type>
+inline const typename ChartRendererType<type>::Type chartRendererInstance {};
+
+template<DataFormat format>
+inline const typename DataExtractorType<format>::Type dataExtractorInstance {};
+
+template<std::size_t... index>
+constexpr std::array<const AbstractChartRenderer *, sizeof...(index)>
+makeChartRendererTable(std::index_sequence<index...>) {
+    return {{&chartRendererInstance<static_cast<ChartType>(index)>...}};
+}
+
+template<std::size_t... index>
+constexpr std::array<const DataExtractorInterface *, sizeof...(index)>
+makeDataExtractorTable(std::index_sequence<index...>) {
+    return {{&dataExtractorInstance<static_cast<DataFormat>(index)>...}};
+}
+
+inline constexpr auto chartRendererTable =
+        makeChartRendererTable(std::make_index_sequence<static_cast<std::size_t>(ChartType::Count)>());
+
+inline constexpr auto dataExtractorTable =
+        makeDataExtractorTable(std::make_index_sequence<static_cast<std::size_t>(DataFormat::Count)>());
+
+inline const AbstractChartRenderer *findChartRenderer(ChartType type) {
+    std::size_t index = static_cast<std::size_t>(type);
+    return index < chartRendererTable.size() ? chartRendererTable[index] : nullptr;
+}
+
+// Формат определяется по расширению файла, у сжатого файла - по расширению под расширением архива:
+// data.csv.gz читается как CSV. nullptr для неподдерживаемых файлов
+inline const DataExtractorInterface *findDataExtractor(const QString &filePath) {
+    QFileInfo fileInfo(filePath);
+    bool isCompressed = isCompressedFile(filePath);
+    QString fileExtension = isCompressed ? QFileInfo(fileInfo.completeBaseName()).suffix() : fileInfo.suffix();
+
+    for (const DataFormatInfo &info: dataFormats) {
+        if (fileExtension == QLatin1String(info.extension)) {
+            if (isCompressed && !info.isStreamable) {
+                return nullptr;
+            }
+            return dataExtractorTable[static_cast<std::size_t>(info.id)];
+        }
+    }
+    return nullptr;
+}
+
+#endif // CHARTREGISTRY_H
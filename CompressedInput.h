@@ -0,0 +1,342 @@
+#ifndef COMPRESSEDINPUT_H
+#define COMPRESSEDINPUT_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <zlib.h>
+#ifdef CHART_DRAWER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Ограниченная очередь блоков между потоком распаковки и парсером
+class BlockQueue
+{
+public:
+    explicit BlockQueue(size_t capacity)
+        : capacity(capacity)
+    {}
+
+    // Ждет свободного места. Возвращает false, если чтение прекращено и блок больше не нужен
+    bool push(QByteArray block)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return blocks.size() < capacity || cancelled; });
+        if (cancelled) {
+            return false;
+        }
+        blocks.push_back(std::move(block));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Ждет следующего блока. Возвращает false, если блоков больше не будет
+    bool pop(QByteArray &block)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !blocks.empty() || finished || cancelled; });
+        if (blocks.empty()) {
+            return false;
+        }
+        block = std::move(blocks.front());
+        blocks.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Производитель закончил работу
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        notEmpty.notify_all();
+    }
+
+    // Блоков больше не будет: очередь пуста, а производитель закончил работу или чтение прекращено
+    bool isDrained() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return blocks.empty() && (finished || cancelled);
+    }
+
+    // Потребитель закончил чтение раньше конца потока
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<QByteArray> blocks;
+    bool finished = false;
+    bool cancelled = false;
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+/*
+ * Последовательное устройство, отдающее распакованное содержимое сжатого файла.
+ * Распаковка идет в отдельном потоке и передается парсеру через ограниченную очередь блоков,
+ * поэтому временные файлы не нужны, а в памяти держится не больше queueCapacity блоков.
+ * Устройство одноразовое: после close() его нельзя открыть снова.
+*/
+class DecompressingDevice : public QIODevice
+{
+public:
+    enum Format {
+        Gzip,
+        Zstd
+    };
+
+    static constexpr int blockSize = 64 * 1024;
+    static constexpr int queueCapacity = 8;
+
+    DecompressingDevice(const QString &filePath, Format format)
+        : source(filePath), format(format), queue(queueCapacity)
+    {}
+
+    ~DecompressingDevice() override
+    {
+        close();
+    }
+
+    bool open(OpenMode mode) override
+    {
+        if (mode & WriteOnly) {
+            return false;
+        }
+        if (!source.open(QIODevice::ReadOnly)) {
+            setErrorString(source.errorString());
+            return false;
+        }
+        QIODevice::open(mode);
+        // До завершения потока файл читается только им
+        producer = std::thread(&DecompressingDevice::decompress, this);
+        return true;
+    }
+
+    void close() override
+    {
+        queue.cancel();
+        if (producer.joinable()) {
+            producer.join();
+        }
+        source.close();
+        QIODevice::close();
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return (block.size() - blockOffset) + QIODevice::bytesAvailable();
+    }
+
+    // Не блокирует: пока поток распаковки работает, конец не достигнут, и следующий блок дождется readData
+    bool atEnd() const override
+    {
+        return !isOpen() || (bytesAvailable() == 0 && queue.isDrained());
+    }
+
+    // Архив поврежден или обрезан. Известно только после того, как прочитано все содержимое
+    bool failed() const
+    {
+        return decompressionFailed;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        // Ждем, пока поток распаковки выдаст следующий блок или закончит работу
+        if (blockOffset >= block.size() && !fetchBlock()) {
+            if (decompressionFailed) {
+                setErrorString("Не удалось распаковать файл");
+                return -1;
+            }
+            return 0;
+        }
+
+        qint64 count = qMin(maxSize, static_cast<qint64>(block.size() - blockOffset));
+        std::memcpy(data, block.constData() + blockOffset, static_cast<size_t>(count));
+        blockOffset += static_cast<int>(count);
+        return count;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    bool fetchBlock()
+    {
+        block.clear();
+        blockOffset = 0;
+        return queue.pop(block);
+    }
+
+    void decompress()
+    {
+#ifdef CHART_DRAWER_HAVE_ZSTD
+        bool isDecompressed = format == Gzip ? inflateGzip() : inflateZstd();
+#else
+        bool isDecompressed = format == Gzip && inflateGzip();
+#endif
+        decompressionFailed = !isDecompressed;
+        queue.finish();
+    }
+
+    bool inflateGzip()
+    {
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // 16 + MAX_WBITS включает разбор gzip-заголовка
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+            return false;
+        }
+
+        QByteArray output(blockSize, Qt::Uninitialized);
+        bool isComplete = false;
+        while (true) {
+            QByteArray input = source.read(blockSize);
+            if (input.isEmpty()) {
+                break;
+            }
+            stream.next_in = reinterpret_cast<Bytef *>(input.data());
+            stream.avail_in = static_cast<uInt>(input.size());
+
+            do {
+                stream.next_out = reinterpret_cast<Bytef *>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+                int status = inflate(&stream, Z_NO_FLUSH);
+                if (status == Z_BUF_ERROR) {
+                    // Продвинуться без новых входных данных нельзя
+                    break;
+                }
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    inflateEnd(&stream);
+                    return false;
+                }
+
+                int produced = output.size() - static_cast<int>(stream.avail_out);
+                if (produced > 0 && !queue.push(QByteArray(output.constData(), produced))) {
+                    inflateEnd(&stream);
+                    return true;
+                }
+
+                isComplete = status == Z_STREAM_END;
+                // Архив может состоять из нескольких склеенных gzip-потоков
+                if (isComplete && inflateReset(&stream) != Z_OK) {
+                    inflateEnd(&stream);
+                    return false;
+                }
+            } while (stream.avail_in > 0 || stream.avail_out == 0);
+        }
+
+        inflateEnd(&stream);
+        return isComplete;
+    }
+
+#ifdef CHART_DRAWER_HAVE_ZSTD
+    bool inflateZstd()
+    {
+        std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream *)> stream(ZSTD_createDStream(), ZSTD_freeDStream);
+        if (!stream || ZSTD_isError(ZSTD_initDStream(stream.get()))) {
+            return false;
+        }
+
+        QByteArray output(static_cast<int>(ZSTD_DStreamOutSize()), Qt::Uninitialized);
+        size_t status = 0;
+        while (true) {
+            QByteArray input = source.read(static_cast<qint64>(ZSTD_DStreamInSize()));
+            if (input.isEmpty()) {
+                break;
+            }
+            ZSTD_inBuffer in = {input.constData(), static_cast<size_t>(input.size()), 0};
+
+            bool isOutputFull = false;
+            do {
+                ZSTD_outBuffer out = {output.data(), static_cast<size_t>(output.size()), 0};
+                status = ZSTD_decompressStream(stream.get(), &out, &in);
+                if (ZSTD_isError(status)) {
+                    return false;
+                }
+                if (out.pos > 0 && !queue.push(QByteArray(output.constData(), static_cast<int>(out.pos)))) {
+                    return true;
+                }
+                isOutputFull = out.pos == out.size;
+            } while (in.pos < in.size || isOutputFull);
+        }
+
+        // Ноль означает, что последний кадр распакован полностью
+        return status == 0;
+    }
+#endif
+
+    QFile source;
+    Format format;
+    BlockQueue queue;
+    std::thread producer;
+    std::atomic<bool> decompressionFailed {false};
+    QByteArray block;
+    int blockOffset = 0;
+};
+
+// Сжатый файл определяется по последнему расширению: data.csv.gz, data.json.gz, data.csv.zst
+inline bool isCompressedFile(const QString &filePath)
+{
+    QString suffix = QFileInfo(filePath).suffix();
+#ifdef CHART_DRAWER_HAVE_ZSTD
+    return suffix == "gz" || suffix == "zst";
+#else
+    return suffix == "gz";
+#endif
+}
+
+// Распаковка сжатого файла оборвалась на поврежденных данных. Для несжатого файла всегда false
+inline bool isInputFailed(const QIODevice &device)
+{
+    const DecompressingDevice *decompressingDevice = dynamic_cast<const DecompressingDevice *>(&device);
+    return decompressingDevice && decompressingDevice->failed();
+}
+
+// Открывает файл для чтения, сжатые файлы распаковываются на лету. nullptr, если файл открыть не удалось
+inline std::unique_ptr<QIODevice> openInputFile(const QString &filePath,
+                                                QIODevice::OpenMode mode = QIODevice::ReadOnly)
+{
+    std::unique_ptr<QIODevice> device;
+    QString suffix = QFileInfo(filePath).suffix();
+
+    if (suffix == "gz") {
+        device = std::make_unique<DecompressingDevice>(filePath, DecompressingDevice::Gzip);
+#ifdef CHART_DRAWER_HAVE_ZSTD
+    } else if (suffix == "zst") {
+        device = std::make_unique<DecompressingDevice>(filePath, DecompressingDevice::Zstd);
+#endif
+    } else {
+        device = std::make_unique<QFile>(filePath);
+    }
+
+    if (!device->open(mode)) {
+        return nullptr;
+    }
+    return device;
+}
+
+#endif // COMPRESSEDINPUT_H
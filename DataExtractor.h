@@ -1,6 +1,7 @@
 #ifndef DATAEXTRACTOR_H
 #define DATAEXTRACTOR_H
 
+#include "CompressedInput.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlRecord>
@@ -12,72 +13,91 @@
 #include <QString>
 #include <QMap>
 #include <QFile>
+#include <QDate>
+#include <QTextStream>
+#include <QThread>
+#include <memory>
 
+// Извлекатели не хранят состояния, один экземпляр можно использовать из нескольких потоков
 class DataExtractorInterface
 {
 public:
     virtual ~DataExtractorInterface() {}
-    virtual bool checkFile(const QString &filePath) = 0;
-    virtual QList<QPair<QString, QString>> extractData(const QString& filePath) = 0;
+    virtual bool checkFile(const QString &filePath) const = 0;
+    // ok становится false, если файл не удалось прочитать целиком, например сжатый файл поврежден
+    virtual QList<QPair<QString, QString>> extractData(const QString& filePath, bool *ok = nullptr) const = 0;
 };
 
 class SqlDataExtractor : public DataExtractorInterface
 {
 public:
-    bool checkFile(const QString& filePath)
+    bool checkFile(const QString& filePath) const
     {
         if (!QFile::exists(filePath)) {
             return false;
         }
 
-        if (!QSqlDatabase::contains("qt_sql_default_connection")) {
-            QSqlDatabase::addDatabase("QSQLITE");
-        }
-        QSqlDatabase database = QSqlDatabase::database();
-        database.setDatabaseName(filePath);
-        if (!database.open()) {
-            return false;
+        QStringList tables;
+        QString connectionName = threadConnectionName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(filePath);
+            if (database.open()) {
+                tables = database.tables();
+                database.close();
+            }
         }
-
-        QStringList tables = database.tables();
-        database.close();
+        QSqlDatabase::removeDatabase(connectionName);
 
         return !tables.isEmpty();
     };
 
-    QList<QPair<QString, QString>> extractData(const QString& filePath)
+    QList<QPair<QString, QString>> extractData(const QString& filePath, bool *ok = nullptr) const
     {
         QList<QPair<QString, QString>> extractedData;
-
-        if (!QSqlDatabase::contains("qt_sql_default_connection")) {
-            QSqlDatabase::addDatabase("QSQLITE");
-        }
-        QSqlDatabase database = QSqlDatabase::database();
-        database.setDatabaseName(filePath);
-        database.open();
-
-        QStringList tables = database.tables();
-        QString tableName = tables.first();
-
-        QSqlQuery query("SELECT * FROM " + tableName + " ");
-        query.exec();
-
         QMap<QString, QPair<double, int>> groupedData;
+        bool isOpened = false;
+
+        QString connectionName = threadConnectionName();
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            database.setDatabaseName(filePath);
+            QStringList tables;
+            if (database.open()) {
+                tables = database.tables();
+            }
+            isOpened = !tables.isEmpty();
+
+            if (isOpened) {
+                QString tableName = tables.first();
+
+                QSqlQuery query(database);
+                query.exec("SELECT * FROM " + tableName + " ");
+
+                // Группируем данные по ключу и вычисляем сумму и количество значений
+                while (query.next()) {
+                    QString unpreparedKey = query.value(0).toString();
+                    QString preparedKey = unpreparedKey.split(' ').first();
+                    double value = query.value(1).toDouble();
+
+                    if (groupedData.contains(preparedKey)) {
+                        QPair<double, int> pair = groupedData.value(preparedKey);
+                        double sum = pair.first;
+                        int count = pair.second;
+                        groupedData[preparedKey] = qMakePair(sum + value, count + 1);
+                    } else {
+                        groupedData[preparedKey] = qMakePair(value, 1);
+                    }
+                }
 
-        // Группируем данные по ключу и вычисляем сумму и количество значений
-        while (query.next()) {
-            QString unpreparedKey = query.value(0).toString();
-            QString preparedKey = unpreparedKey.split(' ').first();
-            double value = query.value(1).toDouble();
-
-            if (groupedData.contains(preparedKey)) {
-                QPair<double, int> pair = groupedData.value(preparedKey);
-                double sum = pair.first;
-                int count = pair.second;
-                groupedData[preparedKey] = qMakePair(sum + value, count + 1);
-            } else {
-                groupedData[preparedKey] = qMakePair(value, 1);
+                query.finish();
             }
+            database.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+
+        if (ok) {
+            *ok = isOpened;
         }
 
         // Вычисляем среднее значение для каждого ключа
@@ -97,28 +117,33 @@ public:
             return date1 < date2;
         });
 
-        database.close();
-
         return extractedData;
     }
+
+private:
+    // Соединение с БД нельзя использовать из разных потоков, поэтому у каждого потока оно свое
+    static QString threadConnectionName()
+    {
+        return QString("chart_drawer_%1").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    }
 };
 
 // Конкретная реализация DataExtractor для формата JSON
 class JsonDataExtractor : public DataExtractorInterface
 {
 public:
-    bool checkFile(const QString& filePath)
+    bool checkFile(const QString& filePath) const
     {
 
-        QFile file(filePath);
         // Проверяем, существует ли файл и может ли он быть открыт для чтения
-        if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        std::unique_ptr<QIODevice> file = openInputFile(filePath);
+        if (!file) {
             return false;
         }
 
         // Читаем только необходимый минимум данных, чтобы проверить файл на валидность
-        QByteArray jsonData = file.read(1024);
-        file.close();
+        QByteArray jsonData = file->read(1024);
+        file->close();
 
         QJsonParseError jsonError;
         // Пытаемся распарсить JSON
@@ -139,18 +164,29 @@ public:
         return true;
     };
 
-    QList<QPair<QString, QString>> extractData(const QString& filePath)
+    QList<QPair<QString, QString>> extractData(const QString& filePath, bool *ok = nullptr) const
     {
         QList<QPair<QString, QString>> extractedData;
-        // Открытие файла для чтения
-        QFile file(filePath);
-        file.open(QIODevice::ReadOnly);
+        // Открытие файла для чтения, сжатый файл распаковывается по мере чтения
+        std::unique_ptr<QIODevice> file = openInputFile(filePath);
+        if (!file) {
+            if (ok) {
+                *ok = false;
+            }
+            return extractedData;
+        }
         // Чтение содержимого файла в виде JSON-данных
-        QByteArray jsonData = file.readAll();
+        QByteArray jsonData = file->readAll();
+        // Обрезанный архив дает обрезанный JSON, который не должен выглядеть пустым файлом
+        bool isRead = !isInputFailed(*file);
         // Закрытие файла
-        file.close();
+        file->close();
         // Создание JSON-документа из прочитанных данных
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+        QJsonParseError jsonError;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &jsonError);
+        if (ok) {
+            *ok = isRead && jsonError.error == QJsonParseError::NoError;
+        }
         // Получение корневого объекта JSON
         QJsonObject jsonObj = jsonDoc.object();
         // Получение значения "data" из корневого объекта
@@ -183,22 +219,20 @@ public:
 class CsvDataExtractor : public DataExtractorInterface
 {
 public:
-    bool checkFile(const QString& filePath)
+    bool checkFile(const QString& filePath) const
     {
-        // Создаем объект QFile для работы с файлом по указанному пути
-        QFile file(filePath);
-
-        // Открываем файл в режиме чтения и текстовом режиме
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        // Открываем файл в режиме чтения и текстовом режиме, сжатый файл распаковывается по мере чтения
+        std::unique_ptr<QIODevice> file = openInputFile(filePath, QIODevice::ReadOnly | QIODevice::Text);
+        if (!file) {
             // Если не удалось открыть файл, возвращаем false
             return false;
         }
 
         // Создаем объект QTextStream для чтения данных из файла
-        QTextStream in(&file);
+        QTextStream in(file.get());
         // Считываем первую строку файла, содержащую заголовки столбцов
         QString headerLine = in.readLine();
-        file.close();
+        file->close();
 
         // Разбиваем строку на отдельные заголовки с помощью разделителя ','
         QStringList headers = headerLine.split(',');
@@ -207,15 +241,19 @@ public:
         return (headers.contains("Key") && headers.contains("Value"));
     };
 
-    QList<QPair<QString, QString>> extractData(const QString& filePath)
+    QList<QPair<QString, QString>> extractData(const QString& filePath, bool *ok = nullptr) const
     {
         QList<QPair<QString, QString>> extractedData;
-        // Создаем объект QFile для работы с файлом по указанному пути
-        QFile file(filePath);
-        // Открываем файл в режиме чтения и текстовом режиме
-        file.open(QIODevice::ReadOnly | QIODevice::Text);
+        // Открываем файл в режиме чтения и текстовом режиме, сжатый файл распаковывается по мере чтения
+        std::unique_ptr<QIODevice> file = openInputFile(filePath, QIODevice::ReadOnly | QIODevice::Text);
+        if (!file) {
+            if (ok) {
+                *ok = false;
+            }
+            return extractedData;
+        }
         // Создаем объект QTextStream для чтения данных из файла
-        QTextStream in(&file);
+        QTextStream in(file.get());
         // Считываем первую строку файла, содержащую заголовки столбцов
         QString headerLine = in.readLine();
         // Разбиваем строку на отдельные заголовки с помощью разделителя ','
@@ -242,7 +280,11 @@ public:
             }
         }
 
-        file.close();
+        // Строки до места повреждения прочитаны, но файл целиком не получен
+        if (ok) {
+            *ok = !isInputFailed(*file);
+        }
+        file->close();
         return extractedData;
     }
 };
@@ -0,0 +1,144 @@
+#ifndef RENDERQUALITY_H
+#define RENDERQUALITY_H
+
+#include <QChartView>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QTimer>
+
+using namespace QtCharts;
+
+// QChartView, который замеряет время каждой своей отрисовки и сообщает об изменении размера
+class MeasuredChartView : public QChartView
+{
+    Q_OBJECT
+
+public:
+    explicit MeasuredChartView(QWidget *parent = nullptr)
+        : QChartView(parent)
+    {}
+
+signals:
+    void paintMeasured(qint64 elapsedMs);
+    void resized();
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QChartView::paintEvent(event);
+        emit paintMeasured(timer.elapsed());
+    }
+
+    void resizeEvent(QResizeEvent *event) override
+    {
+        QChartView::resizeEvent(event);
+        emit resized();
+    }
+};
+
+/*
+ * Адаптивный выбор качества отрисовки.
+ * Уровень выбирается по числу точек перед построением диаграммы и понижается,
+ * если отрисовка не укладывается в бюджет времени кадра.
+ * Когда вид простаивает, полное качество возвращается.
+*/
+class RenderQualityController : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Выше этого числа точек анимации отключаются
+    static constexpr int animationPointLimit = 1000;
+    // Выше этого числа точек отключается сглаживание
+    static constexpr int antialiasingPointLimit = 20000;
+    // Бюджет времени на одну отрисовку, мс
+    static constexpr int paintBudgetMs = 16;
+    // Пауза, после которой вид считается простаивающим, мс
+    static constexpr int idleDelayMs = 500;
+
+    enum Tier {
+        Fast,       // Без анимаций и без сглаживания
+        Reduced,    // Без анимаций
+        Full        // Анимации и сглаживание
+    };
+
+    explicit RenderQualityController(QChartView *view, QObject *parent = nullptr)
+        : QObject(parent), view(view)
+    {
+        idleTimer.setSingleShot(true);
+        idleTimer.setInterval(idleDelayMs);
+        connect(&idleTimer, &QTimer::timeout, this, &RenderQualityController::restoreFullQuality);
+    }
+
+    // Выбор уровня качества перед построением диаграммы
+    void prepareRender(int pointCount)
+    {
+        idleTimer.stop();
+        // Пропуск, оставшийся от восстановления качества без отрисовки, к новой диаграмме не относится
+        skipNextMeasurement = false;
+        if (pointCount > antialiasingPointLimit) {
+            applyTier(Fast);
+        } else if (pointCount > animationPointLimit) {
+            applyTier(Reduced);
+        } else {
+            applyTier(Full);
+        }
+    }
+
+    // Экспорт всегда выполняется в полном качестве, независимо от текущего уровня
+    void renderFullQuality(QPainter *painter)
+    {
+        painter->setRenderHint(QPainter::Antialiasing);
+        view->setRenderHint(QPainter::Antialiasing, true);
+        view->render(painter);
+        view->setRenderHint(QPainter::Antialiasing, currentTier != Fast);
+    }
+
+public slots:
+    void paintMeasured(qint64 elapsedMs)
+    {
+        // Отрисовка в полном качестве после простоя заведомо медленная и на уровень не влияет
+        if (skipNextMeasurement) {
+            skipNextMeasurement = false;
+            return;
+        }
+
+        if (elapsedMs > paintBudgetMs && currentTier > Fast) {
+            applyTier(static_cast<Tier>(currentTier - 1));
+        }
+        if (currentTier != Full) {
+            idleTimer.start();
+        }
+    }
+
+private slots:
+    void restoreFullQuality()
+    {
+        applyTier(Full);
+        // Скрытый вид не перерисовывается, и ждать его отрисовки нельзя
+        if (view->isVisible()) {
+            skipNextMeasurement = true;
+            view->viewport()->update();
+        }
+    }
+
+private:
+    void applyTier(Tier tier)
+    {
+        currentTier = tier;
+        view->chart()->setAnimationOptions(tier == Full ? QChart::SeriesAnimations : QChart::NoAnimation);
+        view->setRenderHint(QPainter::Antialiasing, tier != Fast);
+    }
+
+    QChartView *view;
+    QTimer idleTimer;
+    Tier currentTier = Full;
+    bool skipNextMeasurement = false;
+};
+
+#endif // RENDERQUALITY_H
@@ -1,11 +1,24 @@
 #include "mainwindow.h"
 
-int IOCContainer::s_nextTypeId = 1;
+// Выполняется в пуле потоков. Извлекатели из реестра не имеют состояния и общие для всех потоков
+static std::shared_ptr<const PreparedChartData> prepareFile(const QString &filePath) {
+    const DataExtractorInterface *dataExtractor = findDataExtractor(filePath);
+    if (!dataExtractor || !dataExtractor->checkFile(filePath)) {
+        return nullptr;
+    }
+    bool isExtracted = false;
+    QList<QPair<QString, QString>> extractedData = dataExtractor->extractData(filePath, &isExtracted);
+    // Поврежденный сжатый файл сообщается как ошибка, а не строится пустой или обрезанной диаграммой
+    if (!isExtracted) {
+        return nullptr;
+    }
+    return PreparedChartData::prepare(extractedData, QFileInfo(filePath).fileName());
+}
 
 MainWindow::MainWindow(QWidget *parent)
         : QMainWindow(parent) {
-    selectedFilePath = "";
     isChartRendered = false;
+    chartRenderer = nullptr;
 
     openFolderButton = std::make_unique<QPushButton>("Открыть папку", this);
     openFolderButton->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
@@ -15,11 +28,18 @@ MainWindow::MainWindow(QWidget *parent)
     chartTypeLabel->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
 
     chartTypeComboBox = std::make_unique<QComboBox>(this);
-    chartTypeComboBox->addItem("Столбчатая диаграмма");
-    chartTypeComboBox->addItem("Круговая диаграмма");
-    chartTypeComboBox->addItem("Горизонтальная столбчатая диаграмма");
+    // Список диаграмм берется из реестра, в данных элемента хранится ChartType
+    for (const ChartTypeInfo &chartTypeInfo: chartTypes) {
+        chartTypeComboBox->addItem(chartTypeInfo.title, static_cast<int>(chartTypeInfo.id));
+    }
     chartTypeComboBox->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
 
+    categoryLimitSpinBox = std::make_unique<QSpinBox>(this);
+    categoryLimitSpinBox->setRange(0, 1000);
+    categoryLimitSpinBox->setPrefix("Категорий: ");
+    categoryLimitSpinBox->setSpecialValueText("Категорий: авто");
+    categoryLimitSpinBox->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
+
     BWCheckbox = std::make_unique<QCheckBox>("Черно-белая диаграмма", this);
     BWCheckbox->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
 
@@ -29,6 +49,8 @@ MainWindow::MainWindow(QWidget *parent)
     // Список файлов
     fileListView = std::make_unique<QListView>(this);
     fileListView->setMinimumWidth(100);
+    // Несколько выбранных файлов накладываются на одну диаграмму
+    fileListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     fileListView->resize(350, 0);
     fileListView->setStyleSheet("border: 1px solid black; border-radius: 5px; padding: 5px;");
 
@@ -49,7 +71,15 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Layout, в котором будут отображаться QChartView и QLabel
     layout = std::make_unique<QVBoxLayout>();
-    chartView = std::make_unique<QChartView>(this);
+    std::unique_ptr<MeasuredChartView> measuredChartView = std::make_unique<MeasuredChartView>(this);
+    qualityController = std::make_unique<RenderQualityController>(measuredChartView.get());
+    connect(measuredChartView.get(), &MeasuredChartView::paintMeasured,
+            qualityController.get(), &RenderQualityController::paintMeasured);
+    connect(measuredChartView.get(), &MeasuredChartView::resized, this, &MainWindow::handleChartViewResized);
+    extractionWatcher = std::make_unique<QFutureWatcher<std::shared_ptr<const PreparedChartData>>>(this);
+    connect(extractionWatcher.get(), &QFutureWatcher<std::shared_ptr<const PreparedChartData>>::finished,
+            this, &MainWindow::handleExtractionFinished);
+    chartView = std::move(measuredChartView);
     errorLabel = std::make_unique<QLabel>(this);
     errorLabel->setAlignment(Qt::AlignHCenter | Qt::AlignCenter);
     errorLabel->setVisible(false);
@@ -62,6 +92,7 @@ MainWindow::MainWindow(QWidget *parent)
     topLayout->addWidget(openFolderButton.get());
     topLayout->addWidget(chartTypeLabel.get());
     topLayout->addWidget(chartTypeComboBox.get());
+    topLayout->addWidget(categoryLimitSpinBox.get());
     topLayout->addWidget(BWCheckbox.get());
     topLayout->addWidget(exportButton.get());
 
@@ -81,8 +112,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(openFolderButton.get(), &QPushButton::clicked, this, &MainWindow::openFolder);
     connect(this, SIGNAL(errorMessageReceived(QString)), this, SLOT(printErrorLabel(QString)));
-    connect(chartTypeComboBox.get(), SIGNAL(currentTextChanged(const QString&)), this,
-            SLOT(changeChartType(const QString&)));
+    connect(chartTypeComboBox.get(), QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &MainWindow::changeChartType);
+    connect(categoryLimitSpinBox.get(), QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &MainWindow::changeCategoryLimit);
     connect(BWCheckbox.get(), &QCheckBox::stateChanged, this, &MainWindow::updateChartColorMode);
     connect(exportButton.get(), &QPushButton::clicked, this, &MainWindow::exportChart);
 }
@@ -97,6 +130,10 @@ void MainWindow::openFolder() {
             fileSystemModel->setFilter(QDir::NoDotAndDotDot | QDir::Files);
             fileSystemModel->setRootPath(folderPath);
 
+            // Подготовленные данные относятся к прежней папке
+            preparedFiles.clear();
+            requestedFilePaths.clear();
+            extractionWatcher->cancel();
             fileListView->setModel(fileSystemModel.get());
             fileListView->setRootIndex(fileSystemModel->index(folderPath));
 
@@ -111,56 +148,102 @@ void MainWindow::openFolder() {
     }
 }
 
-void MainWindow::handleFileSelectionChanged(const QItemSelection &selected) {
-    if (!selected.isEmpty()) {
-        QModelIndex selectedIndex = selected.indexes().first();
-
-        selectedFilePath = fileSystemModel->filePath(selectedIndex);
-
-        QFileInfo fileInfo(selectedFilePath);
-        QString fileExtension = fileInfo.suffix();
+void MainWindow::handleFileSelectionChanged(const QItemSelection &) {
+    // Строится вся текущая выборка, а не только что добавленные в нее файлы
+    QStringList filePaths;
+    for (const QModelIndex &selectedIndex: ListSelectionModel->selectedIndexes()) {
+        filePaths.append(fileSystemModel->filePath(selectedIndex));
+    }
+    if (filePaths.isEmpty()) {
+        return;
+    }
 
-        if (fileExtension == "sqlite") {
-            dataExtractor = std::make_unique<SqlDataExtractor>();
-        } else if (fileExtension == "json") {
-            dataExtractor = std::make_unique<JsonDataExtractor>();
-        } else if (fileExtension == "csv") {
-            dataExtractor = std::make_unique<CsvDataExtractor>();
-        } else {
-            dataExtractor = nullptr;
+    for (const QString &filePath: filePaths) {
+        if (!findDataExtractor(filePath)) {
             emit errorMessageReceived("Неподдерживаемый тип файла");
             return;
         }
+    }
+    requestedFilePaths = filePaths;
+    showSelection();
+}
 
-        if (dataExtractor->checkFile(selectedFilePath)) {
-            extractedData = dataExtractor->extractData(selectedFilePath);
-            // Мгновенная отрисовка диаграммы выбранного типа при выборе файла
-            changeChartType(chartTypeComboBox->currentText());
-        } else {
+// Строит выбранные файлы, если все они подготовлены, иначе запускает извлечение недостающих
+void MainWindow::showSelection() {
+    // Идущее извлечение само вернется сюда, когда закончится
+    if (extractionWatcher->isRunning() || requestedFilePaths.isEmpty()) {
+        return;
+    }
+
+    QStringList pendingFilePaths;
+    for (const QString &filePath: requestedFilePaths) {
+        if (preparedFiles.find(filePath) == preparedFiles.end()) {
+            pendingFilePaths.append(filePath);
+        }
+    }
+    // Новые файлы извлекаются параллельно в пуле потоков, окно при этом не блокируется
+    if (!pendingFilePaths.isEmpty()) {
+        extractingFilePaths = pendingFilePaths;
+        extractionWatcher->setFuture(QtConcurrent::mapped(extractingFilePaths, prepareFile));
+        return;
+    }
+
+    QVector<std::shared_ptr<const PreparedChartData>> datasets;
+    for (const QString &filePath: requestedFilePaths) {
+        datasets.append(preparedFiles[filePath]);
+    }
+    // Текстовые ключи разных файлов не сопоставить по позиции на оси
+    if (!AlignedChartData::canAlign(datasets)) {
+        emit errorMessageReceived("Наложить можно только файлы, ключи которых - даты или числа");
+        return;
+    }
+    selectedFilePaths = requestedFilePaths;
+    // Данные подготавливаются один раз, все виды диаграмм строятся уже по ним
+    chartModel.setData(std::move(datasets), chartView->chart());
+    // Мгновенная отрисовка диаграммы выбранного типа при выборе файла
+    changeChartType(chartTypeComboBox->currentIndex());
+}
+
+void MainWindow::handleExtractionFinished() {
+    QFuture<std::shared_ptr<const PreparedChartData>> future = extractionWatcher->future();
+    QStringList failedFilePaths;
+    // Отмененное извлечение относится к прежней папке, его результаты не нужны
+    if (!future.isCanceled()) {
+        for (int i = 0; i < extractingFilePaths.size(); ++i) {
+            std::shared_ptr<const PreparedChartData> prepared = future.resultAt(i);
+            if (prepared) {
+                preparedFiles[extractingFilePaths[i]] = prepared;
+            } else {
+                failedFilePaths.append(extractingFilePaths[i]);
+            }
+        }
+    }
+    extractingFilePaths.clear();
+
+    // Пока файлы извлекались, выборка могла измениться: ошибки и построение касаются только последней выборки
+    for (const QString &filePath: requestedFilePaths) {
+        if (failedFilePaths.contains(filePath)) {
             emit errorMessageReceived("Произошла ошибка при проверке файла");
+            return;
         }
     }
+    showSelection();
 }
 
-void MainWindow::changeChartType(const QString &type) {
-    if (selectedFilePath.isEmpty()) {
+void MainWindow::changeChartType(int index) {
+    if (selectedFilePaths.isEmpty() || !chartModel.data()) {
         return;
     }
-    if (type == "Столбчатая диаграмма") {
-        container.RegisterFactory<AbstractChartRenderer, BarChartRenderer>();
-    } else if (type == "Круговая диаграмма") {
-        container.RegisterFactory<AbstractChartRenderer, PieChartRenderer>();
-    } else if (type == "Горизонтальная столбчатая диаграмма") {
-        container.RegisterFactory<AbstractChartRenderer, HorizontalBarChartRenderer>();
-    }
-    chartRenderer = container.GetObject<AbstractChartRenderer>();
+    chartRenderer = findChartRenderer(static_cast<ChartType>(chartTypeComboBox->itemData(index).toInt()));
 
     if (chartRenderer) {
         if (errorLabel) {
             errorLabel->setVisible(false);
         }
         chartView->setVisible(true);
-        chartRenderer->renderChart(extractedData, chartView);
+        chartModel.setCategoryLimit(categoryLimit(), chartView->chart());
+        qualityController->prepareRender(chartRenderer->renderedPointCount(chartModel));
+        chartRenderer->renderChart(chartModel, chartView, BWCheckbox->isChecked());
         isChartRendered = true;
     } else {
         emit errorMessageReceived("Невозможно создать объект диаграммы");
@@ -168,6 +251,29 @@ void MainWindow::changeChartType(const QString &type) {
     }
 }
 
+void MainWindow::changeCategoryLimit(int) {
+    changeChartType(chartTypeComboBox->currentIndex());
+}
+
+// Автоматическое число категорий следует за размером диаграммы, диаграмма перестраивается только при его смене
+void MainWindow::handleChartViewResized() {
+    if (!isChartRendered || !chartRenderer || categoryLimitSpinBox->value() != 0) {
+        return;
+    }
+    if (categoryLimit() != chartModel.currentCategoryLimit()) {
+        changeChartType(chartTypeComboBox->currentIndex());
+    }
+}
+
+// Без явного значения число категорий выбирается по размеру диаграммы вдоль оси категорий
+int MainWindow::categoryLimit() const {
+    int limit = categoryLimitSpinBox->value();
+    if (limit == 0) {
+        limit = CategoryBuckets::limitForExtent(chartRenderer->categoryExtent(chartView->size()));
+    }
+    return limit;
+}
+
 void MainWindow::printErrorLabel(QString text) {
     if (chartView) {
         chartView->setVisible(false);
@@ -177,15 +283,10 @@ void MainWindow::printErrorLabel(QString text) {
 }
 
 void MainWindow::updateChartColorMode(bool isChecked) {
-    if (chartView) {
-        if (isChecked) {
-            std::unique_ptr<QGraphicsColorizeEffect> effect = std::make_unique<QGraphicsColorizeEffect>();
-            effect->setColor(Qt::black);
-            chartView->chart()->setGraphicsEffect(effect.get());
-            // Освобождаем умный указатель
-            effect.release();
-        } else {
-            chartView->chart()->setGraphicsEffect(nullptr);
+    // Серые цвета задаются на месте, без графического эффекта. Цвета темы возвращаются новыми сериями
+    if (chartView && chartRenderer && isChartRendered) {
+        if (!chartRenderer->applyColorMode(chartModel, isChecked)) {
+            changeChartType(chartTypeComboBox->currentIndex());
         }
     }
 }
@@ -204,6 +305,6 @@ void MainWindow::exportChart() {
     QPdfWriter pdfWriter(filePath);
     QPainter painter(&pdfWriter);
 
-    chartView->render(&painter);
+    qualityController->renderFullQuality(&painter);
     painter.end();
 }
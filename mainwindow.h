@@ -1,14 +1,16 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "IOCContainer.h"
 #include "DataExtractor.h"
 #include "ChartDrawer.h"
+#include "ChartRegistry.h"
+#include "RenderQuality.h"
 #include <QMainWindow>
 #include <QPushButton>
 #include <QLabel>
 #include <QComboBox>
 #include <QCheckBox>
+#include <QSpinBox>
 #include <QListView>
 #include <QItemSelectionModel>
 #include <QSplitter>
@@ -18,9 +20,12 @@
 #include <QVBoxLayout>
 #include <QFileDialog>
 #include <QList>
-#include <QGraphicsColorizeEffect>
 #include <QPdfWriter>
 #include <QPainter>
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <map>
+#include <memory>
 
 class MainWindow : public QMainWindow
 {
@@ -36,17 +41,25 @@ signals:
 public slots:
     void openFolder();
     void handleFileSelectionChanged(const QItemSelection&);
-    void changeChartType(const QString&);
+    void changeChartType(int);
+    void changeCategoryLimit(int);
+    void handleChartViewResized();
+    void handleExtractionFinished();
     void printErrorLabel(QString);
     void updateChartColorMode(bool);
     void exportChart();
 
 private:
+    int categoryLimit() const;
+    void showSelection();
+
     std::unique_ptr<QPushButton> openFolderButton;
     std::unique_ptr<QLabel> chartTypeLabel;
     std::unique_ptr<QLabel> errorLabel;
     std::unique_ptr<QChartView> chartView;
+    std::unique_ptr<RenderQualityController> qualityController;   // Качество отрисовки chartView
     std::unique_ptr<QComboBox> chartTypeComboBox;        // Список диаграмм
+    std::unique_ptr<QSpinBox> categoryLimitSpinBox;      // Число категорий, 0 - по размеру диаграммы
     std::unique_ptr<QCheckBox> BWCheckbox;               // Black-white вид
     std::unique_ptr<QPushButton> exportButton;
     std::unique_ptr<QListView> fileListView;
@@ -54,13 +67,15 @@ private:
     std::shared_ptr<QFileSystemModel> fileSystemModel;   // Модель файловой системы для QListView
     std::unique_ptr<QVBoxLayout> layout;                 // Обертка для QLabel и QChartView
     std::unique_ptr<QSplitter> splitter;                // Разделитель
-    std::unique_ptr<DataExtractorInterface> dataExtractor;
-    std::shared_ptr<AbstractChartRenderer> chartRenderer;
-    QList<QPair<QString, QString>> extractedData;
-    QString selectedFilePath;
+    const AbstractChartRenderer *chartRenderer;          // Экземпляр из реестра, не владеющий указатель
+    RetainedChartModel chartModel;                       // Подготовленные данные и построенные серии
+    std::map<QString, std::shared_ptr<const PreparedChartData>> preparedFiles;   // Кэш подготовленных файлов
+    QStringList selectedFilePaths;
+    QStringList requestedFilePaths;                      // Последняя выборка, ее построение может ждать извлечения
+    QStringList extractingFilePaths;                     // Файлы, которые сейчас извлекаются в пуле потоков
+    std::unique_ptr<QFutureWatcher<std::shared_ptr<const PreparedChartData>>> extractionWatcher;
     QItemSelectionModel* ListSelectionModel;
     bool isChartRendered;
-    IOCContainer container;
 };
 
 #endif // MAINWINDOW_H